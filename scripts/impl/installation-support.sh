@@ -6,6 +6,22 @@ if [ "$PARALLELISM" = "" ]; then
     [ "$PARALLELISM" = "" -o "$PARALLELISM" -eq 0 ] && PARALLELISM=1
 fi
 
+# When spock hosts a GNU make jobserver (spock-shell --jobserver) every make shares its job slots, but an explicit "-jN"
+# causes make to ignore the jobserver and run N jobs of its own. Package scripts say "make -j$PARALLELISM", so drop
+# those switches when there's a jobserver.
+if [ -n "$SPOCK_JOBSERVER" ]; then
+    make() {
+        local args=() arg
+        for arg in "$@"; do
+            case "$arg" in
+                -j[0-9]*|--jobs=[0-9]*) ;;
+                *) args=("${args[@]}" "$arg") ;;
+            esac
+        done
+        command make "${args[@]}"
+    }
+fi
+
 ################################################################################
 # Functions to aid package configuration
 
@@ -26,7 +42,8 @@ spock-compiler-incdirs() {
 # Apply patches. The patch names, like "foo" are used to construct a file name
 # that's distributed with Spock and installed in the same place as the package
 # definitions.  E.g., "foo" becomes $SPOCK_PKGDIR/boost-foo.diff when compiling
-# boost.
+# boost.  All the names are passed as one space-separated argument, so callers
+# must quote the list, as in: spock-apply-patches "$patches"
 spock-apply-patches() {
     local patch_names="$1"
     local patch_name
@@ -38,6 +55,164 @@ spock-apply-patches() {
     done
 }
 
+# Extract a downloaded tarball into the current directory. If spock-download
+# also left a framed zstd copy (see --recompress) then its frames are
+# decompressed and extracted in parallel, and if member names are given then
+# only the frames holding those members (or members below those directories)
+# are read.  Falls back to the gzipped tarball if anything goes wrong.
+spock-extract() {
+    local tarball="$1"; shift # member names
+    local zst="${tarball%.gz}.zst"
+    local idx="$zst.idx"
+
+    if [ -r "$zst" -a -r "$idx" ] && type zstd >/dev/null 2>&1; then
+        # Each output line is "COFFSET CSIZE MEMBERS..." for a frame that needs extracting
+        local frames="$(awk -F'\t' -v members="$*" '
+            BEGIN { n = split(members, want, " ") }
+            $1 == "frame" { offset[$2] = $3; size[$2] = $4; order[nframes++] = $2; if (n == 0) needed[$2] = "" }
+            $1 == "member" && n > 0 {
+                for (i = 1; i <= n; ++i) {
+                    w = want[i]; sub(/\/+$/, "", w)
+                    if (($3 == w || substr($3, 1, length(w) + 1) == w "/") && !(($2, w) in seen)) {
+                        seen[$2, w] = 1
+                        needed[$2] = needed[$2] " " w
+                    }
+                }
+            }
+            END { for (i = 0; i < nframes; ++i) if (order[i] in needed) print offset[order[i]], size[order[i]] needed[order[i]] }
+        ' "$idx")"
+
+        local failed= running=0 pids= offset size members
+        while read offset size members; do
+            [ -n "$offset" ] || continue
+            (tail -c +$((offset + 1)) "$zst" |head -c "$size" |zstd -d -q |tar xf - $members) &
+            pids="${pids:+$pids }$!"
+            running=$((running + 1))
+            if [ "$running" -ge "$PARALLELISM" ]; then
+                wait "${pids%% *}" || failed=yes
+                case "$pids" in *" "*) pids="${pids#* }" ;; *) pids= ;; esac
+                running=$((running - 1))
+            fi
+        done <<<"$frames"
+        for pid in $pids; do
+            wait $pid || failed=yes
+        done
+        [ -n "$failed" ] || return 0
+        echo "spock-extract: warning: framed extraction failed; using $tarball" >&2
+    fi
+
+    tar xf "$tarball" "$@"
+}
+
+# Succeeds if a file in directory $1 can be copied to directory $2 with "cp --reflink=always", which creates a copy that
+# shares data blocks with the original until one of them is modified. This needs a file system like btrfs or xfs, and both
+# directories must be on the same file system.
+spock-can-reflink() {
+    local from="$1/.reflink-test-$$" to="$2/.reflink-test-$$" status=1
+    if echo reflink >"$from" 2>/dev/null; then
+        cp --reflink=always "$from" "$to" 2>/dev/null && status=0
+        rm -f "$from" "$to"
+    fi
+    return $status
+}
+
+# Key for the source tree created by extracting tarball $1 and applying patches $2, which is a hash of the tarball and the
+# patch files. Hashing a large tarball takes a while, so its hash is saved next to it.
+spock-source-key() {
+    local tarball="$1" patch_names="$2" patch_name
+    local sum="$tarball.sha1"
+    if [ ! -s "$sum" -o "$tarball" -nt "$sum" ]; then
+        sha1sum <"$tarball" |cut -d' ' -f1 >"$sum.$$" && mv "$sum.$$" "$sum" || return 1
+    fi
+    local content
+    content="$(
+        cat "$sum" || exit 1
+        for patch_name in $patch_names; do
+            echo "$patch_name"
+            [ "$patch_name" = "none" ] || cat "${SPOCK_PKGDIR}/${PACKAGE_NAME}-$patch_name.diff" || exit 1
+        done
+    )" || return 1
+    echo "$PACKAGE_NAME-$PACKAGE_VERSION-$(echo "$content" |sha1sum |cut -c1-16)"
+}
+
+# Remove the least recently used source trees from cache $1 until its size is at most $SPOCK_SOURCE_CACHE_SIZE, which is a
+# number of bytes optionally followed by "K", "M", "G", or "T" (powers of 1024). The tree with key $2 is never removed.
+spock-source-cache-evict() {
+    local cache="$1" keep="$2"
+    local limit=$(numfmt --from=iec "${SPOCK_SOURCE_CACHE_SIZE:-20G}" 2>/dev/null)
+    [ -n "$limit" ] || return 0
+    limit=$((limit / 1024))
+
+    # Each tree's "info" file holds its size in KiB and is touched when the tree is used. Builds hold a shared lock on it
+    # while copying the tree, so trees that are being copied are skipped. Trees are renamed before they're deleted so that
+    # no build copies a partly deleted tree.
+    local total=0 info entry size
+    for info in $(ls -t "$cache"/*/info 2>/dev/null); do
+        entry="${info%/info}"
+        size=$(cat "$info" 2>/dev/null) || size=0
+        total=$((total + ${size:-0}))
+        if [ "$total" -gt "$limit" -a "${entry##*/}" != "$keep" ]; then
+            (flock -n -x 9 && mv "$entry" "$cache/.old-$$-${entry##*/}") 9<"$info" 2>/dev/null &&
+                rm -rf "$cache/.old-$$-${entry##*/}"
+        fi
+    done
+
+    # Leftovers from builds that were killed.
+    find "$cache" -mindepth 1 -maxdepth 1 \( -name '.new-*' -o -name '.old-*' \) -mmin +1440 -exec rm -rf {} + 2>/dev/null || true
+    return 0
+}
+
+# Extract tarball $1 into the current directory and apply patches $2, the same as spock-extract followed by
+# spock-apply-patches. Like that function, the patch names are one quoted, space-separated argument, which is forwarded
+# to it as a single argument and also keys the cache. The extracted and patched tree is cached in $SPOCK_SOURCE_CACHE (default "source-trees" under
+# $SPOCK_BLDDIR, where the builds happen) so that building the same source more than once, such as with several compilers,
+# extracts and patches it only once. Each build gets a writable copy made with "cp --reflink=always", which is fast and
+# uses no additional space until files are modified. If the file system doesn't support that, or $SPOCK_SOURCE_CACHE is
+# set to the empty string, then the tarball is extracted and patched every time as before.
+spock-prepare-source() {
+    local tarball="$1" patch_names="$2"
+    local cache="${SPOCK_SOURCE_CACHE-${SPOCK_BLDDIR:+$SPOCK_BLDDIR/source-trees}}"
+    local key=
+    if [ -n "$cache" ] && type flock >/dev/null 2>&1 && mkdir -p "$cache" 2>/dev/null && spock-can-reflink "$cache" .; then
+        key=$(spock-source-key "$tarball" "$patch_names") || key=
+    fi
+    if [ -z "$key" ]; then
+        spock-extract "$tarball" && spock-apply-patches "$patch_names"
+        return
+    fi
+
+    local entry="$cache/$key"
+    if [ ! -d "$entry/tree" ]; then
+        local tmp
+        tmp=$(mktemp -d "$cache/.new-XXXXXXXX") || return 1
+        if ! (mkdir "$tmp/tree" && cd "$tmp/tree" && spock-extract "$tarball" && spock-apply-patches "$patch_names"); then
+            rm -rf "$tmp"
+            return 1
+        fi
+        du -sk "$tmp/tree" |cut -f1 >"$tmp/info"
+
+        # Another build may have cached the same tree in the meantime, in which case theirs is used.
+        mv -T "$tmp" "$entry" 2>/dev/null || rm -rf "$tmp"
+        spock-source-cache-evict "$cache" "$key"
+    else
+        echo "spock-prepare-source: using cached source tree $entry"
+    fi
+
+    # The shared lock keeps the tree from being evicted while it's copied. If the copy fails anyway, such as when the tree
+    # was evicted before the lock was taken or the file system is full, whatever was copied is removed so that the tarball
+    # isn't extracted and patched on top of a partial tree.
+    if (flock -s 9 || exit 1
+        cp -a --reflink=always "$entry/tree/." . && exit 0
+        find "$entry/tree" -mindepth 1 -maxdepth 1 -printf '%f\0' |xargs -0 -r rm -rf --
+        exit 1) 9<"$entry/info" 2>/dev/null; then
+        touch "$entry/info" 2>/dev/null || true
+        return 0
+    fi
+
+    echo "spock-prepare-source: warning: cannot copy $entry; extracting $tarball" >&2
+    spock-extract "$tarball" && spock-apply-patches "$patch_names"
+}
+
 ################################################################################
 # Functions to set up the YAML "environment" section of the installed.yaml file.
 if [ "$PACKAGE_ACTION" = "install" ]; then
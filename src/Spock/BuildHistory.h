@@ -0,0 +1,98 @@
+#ifndef Spock_BuildHistory_H
+#define Spock_BuildHistory_H
+
+#include <Spock/Context.h>
+#include <Spock/VersionNumber.h>
+
+#include <boost/filesystem.hpp>
+#include <ctime>
+
+namespace Spock {
+
+/** How long one installation attempt took.
+ *
+ *  An attempt is divided into phases ("download", "solve", "lock", "extract", "build", "register", and "post-install"), each
+ *  with its elapsed time. Phases that ran a script also have the CPU time and peak memory reported by wait4. */
+class BuildTimes {
+public:
+    /** One phase of an installation. */
+    struct Phase {
+        std::string name;
+        double seconds;                                 // elapsed wall clock time
+        bool hasUsage;                                  // whether usage is known
+        Context::ResourceUsage usage;                   // resources used by the phase's script, if any
+
+        Phase(): seconds(0.0), hasUsage(false) {}
+        Phase(const std::string &name, double seconds): name(name), seconds(seconds), hasUsage(false) {}
+    };
+
+    std::string package;                                // package name
+    std::string version;                                // package version
+    std::string hash;                                   // installation hash, even if the attempt failed
+    bool succeeded;                                     // whether the package was installed
+    std::time_t when;                                   // when the attempt finished
+    std::vector<Phase> phases;                          // in the order they ran
+
+    BuildTimes(): succeeded(false), when(0) {}
+
+    /** Sum of the phase times. */
+    double total() const;
+
+    /** Save as a YAML file.
+     *
+     *  The file is replaced atomically. Throws an Exception::ResourceError if it can't be written. */
+    void save(const boost::filesystem::path &yamlFile) const;
+};
+
+/** History of installation times.
+ *
+ *  Every installation attempt, successful or not, appends one line to "build-history" in $SPOCK_OPTDIR with a single
+ *  O_APPEND write, so the expected installation time of a package can be estimated without reading one file per installed
+ *  package. The fields are tab-separated: name, version, hash, "installed" or "failed", Unix time, total seconds, and a
+ *  comma-separated list of "PHASE=SECONDS". The more detailed record of each attempt is saved as YAML by @ref
+ *  BuildTimes::save in the installation prefix, or next to the log of a failed attempt.
+ *
+ *  The history is loaded the first time it's needed. */
+class BuildHistory {
+    typedef Sawyer::Container::Map<std::string /*hash*/, size_t /*index*/> Index;
+
+    boost::filesystem::path optdir_;
+    bool isLoaded_;
+    std::vector<BuildTimes> records_;                   // in the order they were appended
+    Index byHash_;                                      // latest successful record for each hash
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** History of packages installed in the context's installation directory. */
+    explicit BuildHistory(const Context&);
+
+    /** Append a record.
+     *
+     *  Errors are reported as warnings since the history is advisory. */
+    void record(const BuildTimes&);
+
+    /** Recorded time to install a package, or a negative number if unknown.
+     *
+     *  For an installed package this is the time it actually took, if that was recorded. Otherwise it's the average time of
+     *  the most recent successful installations of the same name and version (the greatest version of a ghost), or of the
+     *  same name and any version if that version has never been installed. */
+    double expected(const PackagePtr&);
+
+    /** Expected time to install a particular version of a package, or a negative number if unknown. */
+    double expected(const std::string &name, const VersionNumber &version);
+
+    /** Costs for @ref Context::sortByCriticalPath.
+     *
+     *  Returns the expected installation time of each package that isn't installed yet, indexed by package spec. Packages
+     *  with no history get the average of all known installation times so they're not assumed to be free. */
+    Sawyer::Container::Map<std::string, double> installationCosts(const Packages&);
+
+private:
+    boost::filesystem::path historyName() const;
+    void load();
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef Spock_Compatibility_H
+#define Spock_Compatibility_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#if SAWYER_MULTI_THREADED
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Spock {
+
+/** Persistent relationships between pairs of installed packages.
+ *
+ *  An installed package never changes once its hash exists, so whether two installed packages conflict, whether their
+ *  dependencies conflict, and whether one depends on the other are the same every time the solver asks. Rather than working
+ *  these out from aliases and dependency lists on every solve, they're computed once and saved in "compatibility.cache" in
+ *  $SPOCK_OPTDIR.
+ *
+ *  The file is a series of lines. "+HASH ROW" adds a package, where ROW has one hexadecimal digit of @ref Relation bits for
+ *  each package added before it, in order, or "." if that package wasn't installed when the row was computed. "-HASH" says
+ *  that a package was removed. A package that's reinstalled gets a new row that supersedes the old one. Lines are appended
+ *  while holding an exclusive lock on "compatibility.lock", and when removed packages outnumber the installed ones the file
+ *  is rewritten without them and replaced atomically. Readers don't lock; they stop at the first incomplete or inconsistent
+ *  line and treat the packages after it as unknown.
+ *
+ *  The file is loaded the first time a relationship is needed. The first time a process asks about a package that has no row,
+ *  rows are appended for all installed packages that don't have one yet, including those installed before the cache existed.
+ *  Relationships that still aren't cached after that are computed directly. Either way, the dependency closure of each
+ *  installed package is computed at most once per process.
+ *
+ *  The loaded rows are shared read-only: a change replaces them with a modified copy rather than changing them in place. A
+ *  solver takes a @ref snapshot when it starts and looks up cached pairs in it without locking, so solvers running in
+ *  parallel don't contend for the mutex. Only pairs missing from the snapshot take the locked path. */
+class Compatibility {
+public:
+    /** Relationship bits between package A and package B. */
+    enum Relation {
+        COMPATIBLE              = 0x00,                 // A and B can be used together
+        CONFLICTS               = 0x01,                 // A excludes B: same name with different hashes, or common aliases
+        DEPENDENCIES_CONFLICT   = 0x02,                 // something A needs excludes something B needs, including A and B
+        DEPENDS_ON              = 0x04,                 // B is a direct or indirect dependency of A
+        DEPENDED_ON             = 0x08,                 // A is a direct or indirect dependency of B
+        UNKNOWN                 = 0x10                  // not cached; the caller must check the packages directly
+    };
+
+private:
+    typedef Sawyer::Container::Map<std::string /*hash*/, size_t /*row*/> Rows;
+
+    // An installed package and everything it needs, directly or indirectly.
+    struct Closure {
+        std::vector<std::string> hashes;                // sorted hashes of the package and its dependencies
+        std::vector<std::pair<std::string, std::string> > names; // sorted (name or alias, hash) of the same packages
+    };
+    typedef std::map<std::string /*hash*/, Closure> Closures;
+
+    // Rows read from the file. A table that might have been handed out as a snapshot is never modified.
+    struct Table {
+        Rows rowsByHash;                                // latest row for each installed package
+        std::vector<std::string> rows;                  // relation digits for each row, one per earlier row
+        std::vector<std::string> hashes;                // package for each row
+        size_t nErased;                                 // rows that were superseded or whose packages were removed
+
+        Table(): nErased(0) {}
+        unsigned relation(const std::string &hashA, const std::string &hashB) const;
+    };
+
+public:
+    /** Read-only snapshot of the cached relationships. */
+    typedef boost::shared_ptr<const Table> TablePtr;
+
+private:
+    boost::filesystem::path optdir_;
+    bool isLoaded_;
+    bool isFilled_;                                     // whether missing rows were already added by this process
+    boost::shared_ptr<Table> table_;                    // rows loaded so far; copied before changing if it's shared
+    Closures closures_;                                 // memoized closures of installed packages
+#if SAWYER_MULTI_THREADED
+    mutable boost::mutex mutex_;
+#endif
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Relationships of packages installed in the specified directory. */
+    explicit Compatibility(const boost::filesystem::path &optdir = boost::filesystem::path());
+
+    /** Directory containing the cache.
+     *
+     * @{ */
+    const boost::filesystem::path& directory() const { return optdir_; }
+    void directory(const boost::filesystem::path&);
+    /** @} */
+
+    /** Cached relationships as loaded so far.
+     *
+     *  The snapshot doesn't change, even when rows are added or removed later, and it can be read without locking. */
+    TablePtr snapshot();
+
+    /** Relationship between two installed packages.
+     *
+     *  Returns a bitwise OR of @ref Relation bits describing package A with respect to package B, or @ref UNKNOWN if either
+     *  package isn't installed. A package is compatible with itself. If either package has no row yet, rows for all uncached
+     *  installed packages are appended to the file first; errors doing so are reported as warnings since the cache only saves
+     *  time.
+     *
+     *  If a @ref snapshot is supplied then a pair that it has is answered from it without locking, and any other pair is
+     *  answered as if there were no snapshot.
+     *
+     * @{ */
+    unsigned relation(const Context&, const PackagePtr &a, const PackagePtr &b);
+    unsigned relation(const Context&, const TablePtr&, const PackagePtr &a, const PackagePtr &b);
+    /** @} */
+
+    /** Record that an installed package was removed. */
+    void erase(const std::string &hash);
+
+    /** Relationship between two installed packages, computed without the cache. */
+    static unsigned compute(const Context&, const PackagePtr &a, const PackagePtr &b);
+
+private:
+    boost::filesystem::path cacheName() const;
+    boost::filesystem::path lockName() const;
+    bool load();
+    Table& writableTable();
+    void insertMissing(const Context&);
+    bool append(const std::string &lines);
+    void compact();
+    static const Closure& closure(const Context&, const PackagePtr&, Closures &memo /*in,out*/);
+    static bool namesConflict(const Closure&, const Closure&);
+    static unsigned relationOf(const PackagePtr &a, const Closure &ca, const PackagePtr &b, const Closure &cb);
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef Spock_CompilerProbe_H
+#define Spock_CompilerProbe_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Discovers what a compiler is by compiling and running small test programs.
+ *
+ *  A compiler is an executable and the flags that are always passed to it, such as "g++ -std=c++11". Probing determines its
+ *  base language ("c", "c++", "fortran", or "cuda"), the language standard it compiles by default ("gnu++11", "c99", etc.),
+ *  its vendor ("gnu", "llvm", "intel", ...), and its version number, or else lists the C++ feature-test macros it defines.
+ *  These are the same results as the "detect-compiler-characteristics" and "detect-compiler-features" scripts.
+ *
+ *  The scripts run one test compilation after another, but most tests don't depend on each other. The base language
+ *  determines which vendor test is needed and the vendor determines which version test is needed, so instead of waiting for
+ *  each answer the probe runs every test that could be needed all at once, each in its own temporary directory, and then
+ *  uses only the results it needs. When only one thread is used, tests are run one at a time as their results are needed.
+ *
+ *  Results are cached in a directory, keyed by the compiler's identity: its executable name, its flags, and its output when
+ *  run with "--version", which is also the "version-output" stored in the compiler.yaml file of each compiler package.
+ *  Replacing a compiler with a different version changes its identity, so stale results are not used. A compiler whose
+ *  version output is empty is never cached. */
+class CompilerProbe {
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** What a compiler is. */
+    struct Characteristics {
+        std::string vendor;                             // "gnu", "llvm", "intel", "ibm", "nvidia", etc.
+        std::string baseLanguage;                       // "c", "c++", "fortran", or "cuda"
+        std::string language;                           // default language standard, such as "gnu++11" or "c99"
+        std::string version;                            // vendor's version number for the compiler
+        std::string versionOutput;                      // output from "--version", or empty if not known for this vendor
+
+        /** Vendor, base language, language, and version separated by colons. */
+        std::string quad() const;
+    };
+
+private:
+    boost::filesystem::path executable_;
+    std::vector<std::string> flags_;
+    std::string baseLanguage_;                          // required base language, or empty to detect it
+    boost::filesystem::path cacheDirectory_;            // where results are cached, or empty for no caching
+    size_t nThreads_;                                   // number of probes to run at once; zero means one per processor
+    bool haveVersionOutput_;                            // has versionOutput_ been initialized?
+    std::string versionOutput_;                         // output from running the compiler with "--version"
+
+public:
+    /** Prepare to probe a compiler. Nothing is run until results are requested. */
+    CompilerProbe(const boost::filesystem::path &executable, const std::vector<std::string> &flags);
+
+    /** Compiler executable. */
+    const boost::filesystem::path& executable() const { return executable_; }
+
+    /** Flags always passed to the compiler. */
+    const std::vector<std::string>& flags() const { return flags_; }
+
+    /** Required base language.
+     *
+     *  If set, only this base language is tried, otherwise "cuda", "c++", "fortran", and "c" are tried in that order and the
+     *  first one that works is used. Setting an unknown language throws an Exception::SyntaxError.
+     *
+     * @{ */
+    const std::string& baseLanguage() const { return baseLanguage_; }
+    void baseLanguage(const std::string&);
+    /** @} */
+
+    /** Cache directory.
+     *
+     *  Results are read from and saved to this directory, which is created if necessary. An empty name disables the cache.
+     *
+     * @{ */
+    const boost::filesystem::path& cacheDirectory() const { return cacheDirectory_; }
+    void cacheDirectory(const boost::filesystem::path &dir) { cacheDirectory_ = dir; }
+    /** @} */
+
+    /** Number of probes to run at once. Zero means one per processor.
+     *
+     * @{ */
+    size_t nThreads() const { return nThreads_; }
+    void nThreads(size_t n) { nThreads_ = n; }
+    /** @} */
+
+    /** Default cache directory, $SPOCK_VARDIR/compiler-probes, or empty if $SPOCK_VARDIR is not set. */
+    static boost::filesystem::path defaultCacheDirectory();
+
+    /** Output from running the compiler with "--version".
+     *
+     *  The compiler is run the first time this is called. Its standard output is returned regardless of its exit status. */
+    const std::string& versionOutput();
+
+    /** Hash that identifies the compiler, or empty if it has no version output. */
+    std::string identity();
+
+    /** Characteristics of the compiler.
+     *
+     *  Throws an Exception::CommandError if the base language, vendor, or version cannot be determined. */
+    Characteristics characteristics();
+
+    /** C++ features supported by the compiler.
+     *
+     *  Returns the table of C++ language and library feature-test macros and attributes printed by a test program, one
+     *  section per language standard. Throws an Exception::CommandError if the test program cannot be compiled or run, as
+     *  is the case for compilers that don't support C++11. */
+    std::string features();
+
+private:
+    boost::filesystem::path cacheFile(const std::string &what);
+    bool readCache(const std::string &what, std::string &content /*out*/);
+    void writeCache(const std::string &what, const std::string &content);
+    std::string description() const;
+};
+
+} // namespace
+
+#endif
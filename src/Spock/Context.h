@@ -1,8 +1,10 @@
 #ifndef Spock_Context_H
 #define Spock_Context_H
 
+#include <Spock/Compatibility.h>
 #include <Spock/Directory.h>
 #include <Spock/Environment.h>
+#include <Spock/UsageJournal.h>
 
 #include <boost/filesystem.hpp>
 #include <Sawyer/Graph.h>
@@ -34,6 +36,8 @@ private:
     PackagePtr spockItself_;                            // pseudo-package for spock itself
     DefinitionsByName definitionsByName_;               // all known package definitions indexed by their name
     std::vector<EnvStackItem> envStack_;                // stack of environments
+    mutable UsageJournal usage_;                        // last use of installed packages, loaded lazily
+    mutable Compatibility compatibility_;               // relationships between installed packages, loaded lazily
 
 public:
     static Sawyer::Message::Facility mlog;
@@ -74,6 +78,12 @@ public:
     /** Name of directory where packages are installed. */
     boost::filesystem::path optDirectory() const;
 
+    /** Journal of when installed packages were last used by spock-shell. */
+    UsageJournal& usage() const { return usage_; }
+
+    /** Cached relationships between installed packages. */
+    Compatibility& compatibility() const { return compatibility_; }
+
     /** Name of directory containing descriptions of packages that could be installed. */
     boost::filesystem::path packageDirectory() const;
 
@@ -86,6 +96,12 @@ public:
     /** Directory where building of packages occurs. */
     boost::filesystem::path buildDirectory() const;
 
+    /** Spock's directory variables.
+     *
+     *  Returns "NAME=VALUE" pairs for SPOCK_VERSION, SPOCK_SPEC, SPOCK_HOSTNAME, and the directory variables such as
+     *  SPOCK_ROOT and SPOCK_OPTDIR. */
+    std::vector<std::string> directoryVariables() const;
+
     /** Get the name of an installed config file.
      *
      *  The file need not exist yet. */
@@ -129,31 +145,63 @@ public:
     /** Set environment variables based on this context. */
     void setEnvironment() const;
 
+    /** Environment variables at the top of the environment stack. */
+    const Environment& environment() const { return envStack_.back().variables; }
+
+    /** Resources used by a subshell and the processes it waited for. */
+    struct ResourceUsage {
+        double elapsed;                                 // wall clock seconds
+        double userSeconds;                             // CPU time in user mode
+        double systemSeconds;                           // CPU time in the kernel
+        uint64_t maxRssKib;                             // peak resident set size of the largest process
+
+        ResourceUsage(): elapsed(0.0), userSeconds(0.0), systemSeconds(0.0), maxRssKib(0) {}
+    };
+
     struct SubshellSettings {
         std::string progressName;                       // optional: what to show for the progress bar
-        boost::filesystem::path output;                 // optional: where to save output
-
-        SubshellSettings() {}
-        SubshellSettings(const std::string &name): progressName(name) {}
+        boost::filesystem::path output;                 // optional: where to save output; compressed if it ends with ".gz"
+        bool showProgress;                              // show a progress bar while waiting if output is saved
+        ResourceUsage *usage;                           // optional: receives the resources used by the command
+        bool publishSnapshot;                           // publish a ContextSnapshot for spock tools run by the user
+
+        SubshellSettings(): showProgress(true), usage(NULL), publishSnapshot(false) {}
+        SubshellSettings(const std::string &name)
+            : progressName(name), showProgress(true), usage(NULL), publishSnapshot(false) {}
     };
 
     /** Run a command in a subshell.
      *
      *  A subshell is created based on this context, and the command is run in that subshell.  If no command is specified then
-     *  an interactive subshell is run. */
+     *  an interactive subshell is run. If the settings ask for it, which they should only for shells and commands run on the
+     *  user's behalf, a @ref ContextSnapshot is published for the subshell's spock tools in $SPOCK_CONTEXT_SNAPSHOT. If the
+     *  settings name an output file ending with ".gz" then the output is saved as a compressed log (see @ref LogFile). If the
+     *  settings point to a @ref ResourceUsage then it receives the elapsed time and the CPU time and peak memory reported by
+     *  wait4 for the command. */
     CommandStatus subshell(const std::vector<std::string> &command, const SubshellSettings &settings = SubshellSettings()) const;
     CommandStatus subshell(const boost::filesystem::path &exe, const SubshellSettings &settings = SubshellSettings()) const;
 
+    /** Run a command in a subshell with the specified environment.
+     *
+     *  This is the same as @ref subshell except the environment is supplied by the caller rather than the top of a context's
+     *  environment stack, so it can be used without first constructing a context. */
+    static CommandStatus subshell(const Environment&, const std::vector<std::string> &command,
+                                  const SubshellSettings &settings = SubshellSettings());
+
     /** Find the installed pseudo package representing Spock itself. */
     PackagePtr spockItself() const;
 
     /** Scans the installed packages directory and loads all of them into memory. */
     void scanInstalledPackages();
 
-    /** Deregister an installed package. This makes it so the package will no longer be found by findInstalled. */
+    /** Deregister an installed package. This makes it so the package will no longer be found by findInstalled. An installed
+     *  package is also removed from the compatibility cache. */
     void deregister(const PackagePtr&);
 
-    /** Scans a newly installed package. */
+    /** Scans a newly installed package.
+     *
+     *  The package isn't added to the compatibility cache here; that happens the next time some process needs its
+     *  relationships. */
     PackagePtr scanInstalledPackage(const PackagePattern&);
     
     /** Find packages matching pattern, installed or not. */
@@ -184,6 +232,14 @@ public:
     /** Sort packages so dependencies come before things that depend on them. */
     static void sortByDependencyLattice(Packages&);
 
+    /** Sort packages so dependencies come first and long chains of work start early.
+     *
+     *  Each package's critical path is its own cost plus the longest critical path of the packages that depend on it, where
+     *  costs are expected installation times in seconds indexed by package spec (missing costs are zero). Packages are
+     *  ordered by repeatedly choosing, from those whose dependencies have already been chosen, the one with the longest
+     *  critical path. Ties keep the order from @ref sortByDependencyLattice. */
+    static void sortByCriticalPath(Packages&, const Sawyer::Container::Map<std::string, double> &costs);
+
 private:
     // Add ghost packages to the mix
     void scanGhostPackages();
@@ -0,0 +1,74 @@
+#ifndef Spock_ContextSnapshot_H
+#define Spock_ContextSnapshot_H
+
+#include <Spock/Daemon.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Read-only description of a context, published for nested spock tools.
+ *
+ *  Constructing a @ref Context scans every installed package and every package definition, which is far more than tools like
+ *  spock-using and "spock-ls --shellvars" need when they run inside a spock-shell. Before running a subshell, a context
+ *  writes a snapshot of its directory variables and employed packages to a file in the build directory and points
+ *  $SPOCK_CONTEXT_SNAPSHOT at it. The file is removed when the subshell exits. This is done only for the shells and commands
+ *  that spock-shell runs for the user, not for installation scripts, including those it starts from a daemon's solution
+ *  without a context of its own. If the file can't be written, the variable is not set.
+ *
+ *  A nested tool that finds a usable snapshot answers from it without constructing a context. A snapshot is usable only if
+ *  it was written by this version of spock for the same $SPOCK_OPTDIR and $SPOCK_EMPLOYED, and if the installed-package
+ *  directory has the same generation, which combines its modification time with the number of entries in it. Installing or
+ *  removing a package changes the generation, even within the resolution of the file system's time stamps, so a stale
+ *  snapshot is never used. Otherwise the tool does the work itself as it always has. */
+class ContextSnapshot {
+    std::string optdir_;                                // $SPOCK_OPTDIR
+    uint64_t generation_;                               // generation of optdir_ when the snapshot was taken
+    std::string employedVar_;                           // value of $SPOCK_EMPLOYED for the subshell
+    std::vector<std::string> variables_;                // "NAME=VALUE" directory variables
+    Daemon::PackageRecords employed_;                   // employed packages in the same order as a new context
+    boost::filesystem::path fileName_;                  // published file, removed by the destructor
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Empty snapshot, usually followed by @ref load. */
+    ContextSnapshot();
+
+    /** Snapshot of a context for a subshell that will have the specified environment. */
+    ContextSnapshot(const Context&, const Environment&);
+
+    /** Snapshot described by a daemon for a subshell that will have the specified environment.
+     *
+     *  This is for a subshell started without constructing a context. The @p variables are from Daemon::Client::info and the
+     *  @p employed packages are from Daemon::Client::employed for the subshell's $SPOCK_EMPLOYED. */
+    ContextSnapshot(const std::vector<std::string> &variables, const Daemon::PackageRecords &employed, const Environment&);
+
+    /** Removes the published file, if any. */
+    ~ContextSnapshot();
+
+    /** Generation of an installed-package directory, or zero if it doesn't exist. */
+    static uint64_t generation(const boost::filesystem::path &optdir);
+
+    /** Write the snapshot to a new file in the specified directory.
+     *
+     *  Returns the name of the file, or an empty path if it could not be written, in which case nested tools will just have to
+     *  construct their own contexts. */
+    boost::filesystem::path publish(const boost::filesystem::path &directory);
+
+    /** Read the snapshot named by $SPOCK_CONTEXT_SNAPSHOT.
+     *
+     *  Returns false if there is no such snapshot or if it is not usable by this process. */
+    bool load();
+
+    /** Spock's directory variables as "NAME=VALUE" pairs, the same as Daemon::Client::info. */
+    const std::vector<std::string>& variables() const { return variables_; }
+
+    /** Employed packages matching any of the patterns, or all employed packages if there are no patterns. */
+    Daemon::PackageRecords employed(const std::vector<std::string> &patterns) const;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef Spock_Daemon_H
+#define Spock_Daemon_H
+
+#include <Spock/Context.h>
+#include <Spock/Environment.h>
+#include <Spock/Wire.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <ctime>
+
+namespace Spock {
+
+/** Resident spock daemon.
+ *
+ *  Every spock tool normally constructs a @ref Context, which scans every installed package and every package definition.
+ *  The spockd daemon keeps one such context in memory for a single $SPOCK_OPTDIR and answers queries over a Unix domain
+ *  socket. It watches the installed-package and package-definition directories with inotify and rebuilds its context
+ *  whenever they change.
+ *
+ *  Tools use the daemon through a @ref Daemon::Client. Every client function returns false if the daemon cannot be used
+ *  for any reason (no socket, no daemon, version or directory mismatch, protocol error) in which case the tool does the
+ *  work itself as it always has. Errors that would also happen in-process (such as a package that isn't installed) are
+ *  thrown as exceptions instead. */
+namespace Daemon {
+
+/** Request types. */
+enum Opcode {
+    OP_INFO = 1,                                        // spock specification and directory variables
+    OP_LIST = 2,                                        // find installed or ghost packages by pattern
+    OP_EMPLOYED = 3,                                    // describe the employed packages
+    OP_SOLVE = 4,                                       // solve constraints in the context of employed packages
+    OP_ENVIRONMENT = 5,                                 // environment changes for employing packages
+    OP_SHUTDOWN = 6                                     // ask the daemon to exit
+};
+
+/** Reply types. */
+enum Status {
+    STATUS_OK = 0,                                      // payload follows
+    STATUS_ERROR = 1,                                   // a Spock exception occurred; message follows
+    STATUS_STALE = 2                                    // daemon cannot answer for this client; client should fall back
+};
+
+/** Kinds of environment changes. */
+enum EnvironmentChange {
+    ENV_DEFAULT = 0,                                    // set variable only if it's not already set
+    ENV_PREPEND = 1,                                    // like Environment::prependUnique
+    ENV_APPEND = 2                                      // like Environment::appendUnique
+};
+
+/** Name of the daemon's socket.
+ *
+ *  This is $SPOCK_DAEMON_SOCKET if that variable is set, otherwise "spockd.sock" in $SPOCK_OPTDIR if that variable is set,
+ *  otherwise empty. Setting $SPOCK_DAEMON_SOCKET to the empty string disables use of the daemon. */
+boost::filesystem::path socketName();
+
+/** Hashes listed in $SPOCK_EMPLOYED, or in a value for that variable.
+ *
+ * @{ */
+std::vector<std::string> employedHashes();
+std::vector<std::string> employedHashes(const std::string &value);
+/** @} */
+
+/** Description of a package sent from the daemon to a client. */
+struct PackageRecord {
+    bool installed;
+    std::string name;
+    std::string version;                                // primary version, possibly empty
+    std::string hash;                                   // empty for ghosts
+    std::string spec;                                   // Package::toString
+    std::vector<std::string> aliases;
+    std::vector<std::string> versions;                  // all versions, for ghosts
+    std::vector<std::string> dependencies;              // dependency patterns
+    std::time_t usedTime;                               // last use by spock-shell, installed packages only
+
+    PackageRecord(): installed(false), usedTime(0) {}
+
+    /** Describe a package. */
+    static PackageRecord fromPackage(const PackagePtr&);
+
+    /** Same as Package::toStringColored. */
+    std::string toStringColored() const;
+
+    void encode(WireWriter&) const;
+    static PackageRecord decode(WireReader&);
+};
+
+typedef std::vector<PackageRecord> PackageRecords;
+
+/** Results of an OP_LIST request. */
+struct ListReply {
+    std::vector<std::string> warnings;                  // patterns that matched nothing
+    PackageRecords packages;                            // sorted and without duplicates, like spock-ls
+    std::string graphViz;                               // dependency graph, if requested
+};
+
+/** Results of an OP_SOLVE request. */
+struct SolveReply {
+    size_t nSolutions;
+    size_t nSteps;
+    std::vector<std::string> messages;
+    PackageRecords solution;                            // first solution sorted by dependency lattice
+    std::string graphViz;                               // dependency graph of the solution
+
+    SolveReply(): nSolutions(0), nSteps(0) {}
+
+    /** True if there's a solution and all its packages are installed. */
+    bool isInstalled() const;
+};
+
+/** Talks to a running daemon. */
+class Client {
+    boost::filesystem::path socket_;
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Client for the socket named by @ref socketName. */
+    Client();
+
+    /** Client for a specific socket. */
+    explicit Client(const boost::filesystem::path &socket);
+
+    /** Name of the socket, or empty if the daemon is disabled. */
+    const boost::filesystem::path& socket() const { return socket_; }
+
+    /** Spock's specification and its directory variables.
+     *
+     *  The @p variables are the "NAME=VALUE" pairs for SPOCK_SPEC, SPOCK_ROOT, SPOCK_BINDIR, etc. as computed by the daemon's
+     *  own context. */
+    bool info(std::vector<std::string> &variables /*out*/);
+
+    /** Find installed or ghost packages.
+     *
+     *  If @p usable is set, packages that cannot be used along with the employed packages are excluded. */
+    bool list(const std::vector<std::string> &patterns, bool ghosts, bool usable, bool graph, ListReply &reply /*out*/);
+
+    /** Describe employed packages matching any of the patterns, or all employed packages if there are no patterns.
+     *
+     *  The employed packages are those listed in $SPOCK_EMPLOYED unless other @p hashes are specified, such as those for a
+     *  subshell that's about to be started.
+     *
+     * @{ */
+    bool employed(const std::vector<std::string> &patterns, PackageRecords &packages /*out*/);
+    bool employed(const std::vector<std::string> &hashes, const std::vector<std::string> &patterns,
+                  PackageRecords &packages /*out*/);
+    /** @} */
+
+    /** Solve constraints in the context of the employed packages. */
+    bool solve(const std::vector<std::string> &patterns, SolveReply &reply /*out*/);
+
+    /** Environment changes needed to employ additional installed packages.
+     *
+     *  Returns the changes that a Context would make to the process environment if the specified packages were employed on
+     *  top of the already-employed packages. If @p stamp is set then the daemon also updates the packages' used time stamps
+     *  as spock-shell would. */
+    bool environment(const std::vector<std::string> &hashes, bool stamp, Environment &env /*in,out*/);
+
+    /** Ask the daemon to exit. */
+    bool shutdown();
+
+private:
+    bool call(Opcode, const WireWriter &args, std::string &reply /*out*/);
+};
+
+/** The daemon itself. */
+class Server {
+    boost::filesystem::path socket_;
+    boost::scoped_ptr<Context> ctx_;                    // null if it needs to be rebuilt
+    int listenFd_;                                      // listening socket
+    int inotifyFd_;                                     // watches optdir and pkgdir
+    int optWatch_, pkgWatch_;                           // inotify watch descriptors
+    bool done_;                                         // set by OP_SHUTDOWN
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Create a daemon that will listen on the specified socket.
+     *
+     *  Throws an Exception::ResourceError if the socket cannot be created or if another daemon is already listening on it. */
+    explicit Server(const boost::filesystem::path &socket);
+    ~Server();
+
+    /** Serve requests until told to shut down. */
+    void run();
+
+private:
+    Context& context();
+    void watchDirectories();
+    void readNotifications();
+    void serveConnection(int fd);
+    Status handleRequest(Opcode, WireReader &args, WireWriter &reply /*out*/);
+    bool isLoaded(std::string &reason /*out*/);
+    bool isCompatible(const std::vector<std::string> &clientVariables, std::string &reason /*out*/);
+    std::vector<std::string> directoryVariables();
+    void employ(const std::vector<std::string> &hashes);
+};
+
+} // namespace
+} // namespace
+
+#endif
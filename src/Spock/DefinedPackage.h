@@ -2,15 +2,32 @@
 #define Spock_DefinedPackage_H
 
 #include <Spock/Context.h>
+#include <Spock/PackagePattern.h>
 #include <Spock/TemporaryDirectory.h>
 #include <Spock/VersionNumber.h>
 
-#include <yaml-cpp/yaml.h>
+#include <map>
+
+#if SAWYER_MULTI_THREADED
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace YAML {
+class Node;
+}
 
 namespace Spock {
 
-/** An installable package. */
+/** An installable package.
+ *
+ *  The YAML file that defines a package is compiled when it's loaded: each property that the package's versions are
+ *  selected from ("dependencies", "download", "install", "post-install", and "variables") is resolved for every version, and
+ *  the YAML tree is then discarded. Versions that select the same item share one copy of its values. The compiled form is
+ *  saved in "definitions" under $SPOCK_VARDIR and reused as long as the YAML file's modification time and size, or else its
+ *  content hash, are unchanged. */
 class DefinedPackage: public Sawyer::SharedObject {
+    friend class GhostPackage;
+
 public:
     typedef Sawyer::SharedPointer<DefinedPackage> Ptr;
     static Sawyer::Message::Facility mlog;
@@ -23,18 +40,56 @@ public:
         bool tryAgain;                                  // true=>try to install even if we've tried before
         boost::filesystem::path installDirOverride;     // to override the usual $BOOST_ROOT/var/installed
         Packages parasites;                             // parasites also installed when the host was installed
+        bool recompress;                                // also keep a framed zstd copy of the download ($SPOCK_RECOMPRESS)
 
-        Settings(): quiet(true), keepTempFiles(false), tryAgain(false) {}
+        Settings(): quiet(true), keepTempFiles(false), tryAgain(false), recompress(getenv("SPOCK_RECOMPRESS") != NULL) {}
     };
 
 private:
+    // Properties resolved for each version.
+    enum PropertyId {
+        INSTALL_DEPENDENCIES,                           // dependencies.VERSION.install
+        BUILD_DEPENDENCIES,                             // dependencies.VERSION.build
+        ALIASES,                                        // dependencies.VERSION.aliases
+        PARASITES,                                      // post-install.VERSION.parasites
+        DOWNLOAD_COMMANDS,                              // download.VERSION.shell
+        INSTALL_COMMANDS,                               // install.VERSION.shell
+        POST_INSTALL_COMMANDS,                          // post-install.VERSION.shell
+        VARIABLES,                                      // all variables.VERSION items, as NAME="VALUE"
+        N_PROPERTIES
+    };
+
+    // A property resolved for one version. Reading a property from the YAML file can fail for some versions and not others,
+    // so a failure is saved and reported when the property is used instead of when the definition is loaded.
+    struct Property {
+        enum Error { NO_ERROR, SYNTAX_ERROR, NOT_FOUND };
+        std::vector<std::string> values;                // scalars in the order they appear in the YAML file
+        std::vector<PackagePattern> patterns;           // values parsed once, for the dependency properties
+        uint8_t error;                                  // an Error
+        std::string message;                            // what reading the property threw
+
+        Property(): error(NO_ERROR) {}
+    };
+
     std::string name_;
     boost::filesystem::path configFile_;
-    YAML::Node config_;
     VersionNumbers versions_;
+    std::vector<VersionNumber> versionList_;            // versions_ in ascending order, indexed by version number
+    std::vector<VersionMask> versionGroups_;            // versions that have the same dependencies, in the order of the file
+    bool hasPostInstall_;                               // whether there's a "post-install" property
+    std::vector<Property> properties_;                  // distinct properties, shared by the versions that select them
+    std::vector<uint32_t> propertyIndex_;               // index into properties_ for each version and PropertyId
+
+    // Flyweight ghosts for subsets of this definition's versions, keyed by package name and aliases (which distinguish the
+    // host from its parasites) and version mask. See GhostPackage::instance.
+    typedef std::pair<std::string, VersionMask> GhostKey;
+    std::map<GhostKey, GhostPackagePtr> ghosts_;
+#if SAWYER_MULTI_THREADED
+    boost::mutex ghostMutex_;
+#endif
 
 protected:
-    // Opens the specified YAML config file for reading and verifies that some things are correct.
+    // The definition is empty until it's loaded.
     DefinedPackage(const std::string &pkgName, const boost::filesystem::path &configFile);
 
 public:
@@ -43,8 +98,10 @@ public:
     /** Obtains a package definition by reading a configuration file.
      *
      *  This is a low-level function. It is better to obtain package definitions by the Context object, which also caches
-     *  them. */
-    static Ptr instance(const std::string &pkgName, const boost::filesystem::path &configFile);
+     *  them. If a cache directory is specified then the compiled definition is read from there when it's up to date, and
+     *  saved there otherwise. */
+    static Ptr instance(const std::string &pkgName, const boost::filesystem::path &configFile,
+                        const boost::filesystem::path &cacheDirectory = boost::filesystem::path());
 
     /** Name of package.
      *
@@ -68,18 +125,56 @@ public:
      *  The specified version must be exact, i.e., "=" comparison. */
     bool isSupportedVersion(const VersionNumber&) const;
 
+    /** Dense version numbering.
+     *
+     *  The supported versions are numbered from zero in ascending order, and these numbers index the bits of a @ref
+     *  VersionMask. The @ref versionIndex function returns the number for a supported version, or @ref INVALID_INDEX if the
+     *  version isn't supported. Like @ref isSupportedVersion, the version must be spelled the same as in the definition.
+     *
+     * @{ */
+    static const size_t INVALID_INDEX = (size_t)(-1);
+    size_t nVersions() const { return versionList_.size(); }
+    const VersionNumber& versionAt(size_t idx) const;
+    size_t versionIndex(const VersionNumber&) const;
+    /** @} */
+
+    /** Convert between version sets and masks.
+     *
+     *  Every version in the set must be supported, although it may be spelled differently as long as it sorts the same, such
+     *  as "1.02" for "1.2".
+     *
+     * @{ */
+    VersionMask versionMask(const VersionNumbers&) const;
+    VersionNumbers versionNumbers(const VersionMask&) const;
+    /** @} */
+
+    /** Forget the ghosts created from this definition.
+     *
+     *  Ghost packages refer to their definition and the definition caches its ghosts, so the cache must be cleared before
+     *  the definition can be freed. Ghosts that are still referenced elsewhere remain valid but are no longer shared. */
+    void clearGhosts();
+
     /** Installation dependencies.
      *
      *  Since this is only a package definition and not an actual installed package, the dependencies are patterns rather than
      *  specific installations of packages. */
-    std::vector<PackagePattern> dependencyPatterns(const VersionNumber &vers);
+    std::vector<PackagePattern> dependencyPatterns(const VersionNumber &vers) const;
     
     /** Download the package from its upstream location.
      *
      *  Downloaded files are cached in $SPOCK_VAR/downloads, and the return value is the name of this file. The filenames in
-     *  this directory follow the pattern PACKAGE-VERSION.tar.gz and usually untar into a "download" directory. */
+     *  this directory follow the pattern PACKAGE-VERSION.tar.gz and usually untar into a "download" directory. If the
+     *  settings ask for recompression then a framed zstd copy is also created if it doesn't exist yet (see @ref
+     *  FramedTarball); failure to create it is only a warning since the gzipped tarball is still usable. */
     boost::filesystem::path download(Context&, const Settings&);
 
+    /** Start downloading the package in the background.
+     *
+     *  The download script is created by the calling thread and run quietly by one of the workers. A later @ref download of
+     *  the same version waits for the background download to finish instead of starting another one, and downloads the
+     *  package itself if the background download failed. Does nothing if the tarball is already in the download cache. */
+    void prefetch(Context&, const Settings&, WorkQueue&);
+
     /** Install the package.
      *
      *  Do all steps necessary to install a packge. The version number must be specified the @p settings, but the hash will be
@@ -101,9 +196,21 @@ private:
     // Name of cached download file (might not exist). Usually like "$SPOCK_VAR/downloads/PACKAGE-VERSION.tar.gz".
     boost::filesystem::path cachedDownloadFile(Context &ctx, const Settings&) const;
 
-    // Find shell commands in the config file. Looks for config_[SECTIONNAME][VERSION].
-    std::string findCommands(const std::string &sectionName, const VersionNumber&);
+    // Compile the YAML file, or read the compiled form from the cache directory if it's up to date.
+    void load(const boost::filesystem::path &cacheDirectory);
+    void compile(const std::string &yaml);
+    Property compileProperty(YAML::Node &config, PropertyId, const VersionNumber&) const;
+    void parsePatterns();
+
+    // Compiled definition cache.
+    bool readCache(const boost::filesystem::path &cacheFile, uint64_t mtime, uint64_t size, const std::string &contentHash);
+    void writeCache(const boost::filesystem::path &cacheFile, uint64_t mtime, uint64_t size, const std::string &contentHash);
+
+    // Property for a version. Throws the saved error, if any.
+    const Property& property(const VersionNumber&, PropertyId) const;
 
+    // Shell commands for a version, from one of the *_COMMANDS properties.
+    std::string findCommands(PropertyId, const VersionNumber&) const;
 
     // Return shell variables defined in the configuration for the selected version. Each member of the vector has the form
     // "NAME=VALUE".
@@ -124,7 +231,8 @@ private:
                            const boost::filesystem::path &yamlFile, const boost::filesystem::path &installDir);
 
     // Runs post-install commands, such as installing parasites.
-    void postInstall(Context&, Settings&, const TemporaryDirectory &workingDir, const boost::filesystem::path &pkgRoot);
+    void postInstall(Context&, Settings&, const TemporaryDirectory &workingDir, const boost::filesystem::path &pkgRoot,
+                     Context::ResourceUsage *usage /*out*/);
 
     // Hash of things that affect the configuration
     std::string configHash(Context&, const Settings&, const Packages &installDeps, const Packages &buildDeps);
@@ -3,15 +3,24 @@
 
 #include <Spock/Spock.h>
 
+#include <map>
+
 namespace Spock {
 
-/** Directory of all known packages. */
+/** Directory of all known packages.
+ *
+ *  Packages are indexed by hash, and by each of their names and aliases. The per-name lists and the list of all packages
+ *  are kept in the order defined by @ref sortByNameVersion, which groups installed packages by name and orders each group by
+ *  descending version, so version comparisons in a pattern are answered by binary search within each group. The names are
+ *  kept in an ordered map so that a glob pattern only visits the names that start with the pattern's literal prefix. Results
+ *  are returned in @ref sortByNameVersion order without needing to be sorted. */
 class Directory {
     typedef Sawyer::Container::Map<std::string /*hash*/, PackagePtr> PackagesByHash;
-    typedef Sawyer::Container::Map<std::string /*name*/, Packages> PackagesByName;
+    typedef std::map<std::string /*name*/, Packages> PackagesByName;
 
     PackagesByHash packagesByHash_;                     // all known installed packages indexed by their hash code
-    PackagesByName packagesByName_;                     // all known packages (installed or not) indexed by their name
+    PackagesByName packagesByName_;                     // all known packages (installed or not) indexed by names and aliases
+    Packages allPackages_;                              // all known packages, each once
 
 public:
     Directory();
@@ -27,7 +36,11 @@ public:
 
     void erase(const PackagePtr&);
 
+    /** Packages matching a pattern and satisfying a predicate, sorted by @ref sortByNameVersion without duplicates. */
     Packages find(const PackagePattern&, Predicate) const;
+
+    /** Installed package with the specified hash, or null. */
+    PackagePtr findHash(const std::string &hash) const { return packagesByHash_.getOrDefault(hash); }
 };
 
 } // namespace
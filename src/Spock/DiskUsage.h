@@ -0,0 +1,56 @@
+#ifndef Spock_DiskUsage_H
+#define Spock_DiskUsage_H
+
+#include <Spock/Spock.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <ctime>
+
+namespace Spock {
+
+/** Cached disk usage of installed packages.
+ *
+ *  Measuring the size of an installation prefix means walking the whole tree, which is slow for large packages and for the
+ *  whole $SPOCK_OPTDIR. Since installed packages don't change once installed, their sizes are cached in the file
+ *  "disk-usage" in $SPOCK_OPTDIR. Each line has a package hash, the number of bytes allocated to its installation prefix,
+ *  and the modification time of its YAML file when it was measured. An entry is reused as long as the YAML file has the same
+ *  modification time, which catches a package that's removed and reinstalled with the same hash. Entries for packages that
+ *  are no longer installed are dropped when the cache is loaded. */
+class DiskUsage {
+    struct Entry {
+        uint64_t nBytes;
+        std::time_t configTime;                         // modification time of installed YAML file when measured
+        Entry(): nBytes(0), configTime(0) {}
+    };
+    typedef Sawyer::Container::Map<std::string /*hash*/, Entry> Entries;
+
+    boost::filesystem::path indexFile_;
+    Entries entries_;
+    bool modified_;                                     // entries_ differs from the file
+
+public:
+    /** Load the cached sizes for the installed packages of a context. */
+    explicit DiskUsage(const Context&);
+
+    /** Saves changes, ignoring errors. */
+    ~DiskUsage();
+
+    /** Size of an installed package's prefix, measuring it if necessary. */
+    uint64_t size(const Context&, const InstalledPackagePtr&);
+
+    /** Forget the size of a removed package. */
+    void erase(const std::string &hash);
+
+    /** Write the cache if it changed.
+     *
+     *  The file is replaced atomically. Throws an Exception::ResourceError on failure. */
+    void save();
+
+    /** Number of bytes allocated to a file or directory tree, without following symbolic links. */
+    static uint64_t treeSize(const boost::filesystem::path&);
+};
+
+} // namespace
+
+#endif
@@ -25,6 +25,9 @@ public:
      *  If the variable is not defined, then return the default value without assigning it to the variable. */
     std::string get(const std::string &variable, const std::string &dflt = "") const;
 
+    /** Names of all variables, sorted. */
+    std::vector<std::string> names() const;
+
     /** Append a value to an existing variable.
      *
      *  The variable and new value are assumed to be parts separated by a separator. The parts of the value are
@@ -47,6 +50,11 @@ public:
      *  This completely rewrites the process environment. Any variables that were there before will be erased and replaced with
      *  variables only from this object. */
     void exportVars() const;
+
+    /** Variables as "NAME=VALUE" strings.
+     *
+     *  These are the variables that @ref exportVars would export, in the form needed for the environment of a new process. */
+    std::vector<std::string> assignments() const;
 };
 
 } // namespace
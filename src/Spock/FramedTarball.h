@@ -0,0 +1,45 @@
+#ifndef Spock_FramedTarball_H
+#define Spock_FramedTarball_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Multi-frame zstd copy of a downloaded tarball.
+ *
+ *  The download cache holds each package's source as "NAME-VERSION.tar.gz", which can only be decompressed by a single
+ *  thread. A framed tarball is an optional second copy of the same tar stream, "NAME-VERSION.tar.zst", made of independent
+ *  zstd frames that each end on a tar member boundary. Each frame is therefore a complete tar fragment that can be
+ *  decompressed and extracted on its own, in parallel with the others.
+ *
+ *  The companion index "NAME-VERSION.tar.zst.idx" is a tab-separated text file. Lines of the form "frame N COFFSET CSIZE
+ *  TOFFSET TSIZE" give the compressed byte range of each frame and the range of the tar stream it holds. Lines of the form
+ *  "member FRAME PATH" name each tar member and the frame containing it, so that only the frames holding particular files
+ *  need to be extracted. The index is written last, so a framed copy without an index is incomplete and is ignored.
+ *
+ *  The shell function "spock-extract" in installation-support.sh uses the framed copy when it exists and falls back to the
+ *  gzipped tarball otherwise. Package download scripts are unaffected: they still produce "download.tar.gz". */
+class FramedTarball {
+public:
+    /** Name of the framed copy of a cached tarball. */
+    static boost::filesystem::path archiveName(const boost::filesystem::path &tarball);
+
+    /** Name of the index for the framed copy of a cached tarball. */
+    static boost::filesystem::path indexName(const boost::filesystem::path &tarball);
+
+    /** True if a complete framed copy exists for the tarball. */
+    static bool exists(const boost::filesystem::path &tarball);
+
+    /** Create the framed copy and its index.
+     *
+     *  Reads the gzipped tarball and compresses it again with the "zstd" command, starting a new frame at the first member
+     *  boundary after every @p frameSize bytes of tar data. Any previous framed copy is replaced. Throws an
+     *  Exception::CommandError if the tarball can't be read or zstd fails, in which case no framed copy exists afterward. */
+    static void create(const boost::filesystem::path &tarball, size_t frameSize = 32*1024*1024);
+};
+
+} // namespace
+
+#endif
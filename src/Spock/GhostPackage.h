@@ -10,17 +10,21 @@ namespace Spock {
  *  A ghost package behaves like an installed package (InstalledPackage) except there's no actual package installed. Instead,
  *  ghost packages are generated as placeholders from package definitions (DefinedPackage) to represent something that
  *  <em>could</em> be installed. Since ghost packages aren't actually installed, they have no hash; but they do always have a
- *  name and one or more exact version numbers. */
+ *  name and one or more exact version numbers.
+ *
+ *  Ghosts are flyweights: the versions are a mask over the definition's densely numbered versions, and each combination of
+ *  name, aliases, and versions is represented by one shared object cached by the definition. Therefore a ghost must not be
+ *  modified once it has been created; use @ref instance to obtain a ghost with different versions. */
 class GhostPackage: public Package {
     DefinedPackagePtr defn_;
-    VersionNumbers versions_;
+    VersionMask versions_;
 
 public:
     typedef Sawyer::SharedPointer<GhostPackage> Ptr;
 
 protected:
     GhostPackage();
-    GhostPackage(const DefinedPackagePtr &definition, const VersionNumbers &versions);
+    GhostPackage(const DefinedPackagePtr &definition, const VersionMask &versions);
 
 public:
     ~GhostPackage();
@@ -32,17 +36,43 @@ public:
     virtual VersionNumbers versions() const;
     virtual std::string toString() const;
 
-    /** Create a new instance.
+    /** Obtain an instance.
+     *
+     *  The instance represents a single package capable of installing any of the specified versions. Each version has
+     *  identical dependencies, etc. The version number set cannot be empty. The name defaults to the definition's name, and a
+     *  different name makes the instance a parasite. Requesting the same name, aliases, and versions again returns the same
+     *  object.
      *
-     *  This new instance represents a single package capable of installing any of the specified versions. Each version has
-     *  identical dependencies, etc. The version number set cannot be empty. */
+     * @{ */
     static Ptr instance(const DefinedPackagePtr&, const VersionNumbers&);
+    static Ptr instance(const DefinedPackagePtr&, const std::string &name, const Aliases&, const VersionMask&);
+    /** @} */
 
-    /** Create another instance but different versions.
+    /** Obtain an instance like another but with different versions.
+     *
+     *  The result has the same definition, name, and aliases as the original. The new versions must be a non-empty subset of
+     *  the original versions.
      *
-     *  This is like a copy constructor, but it changes the versions at the same time.  The new versions must be a non-empty
-     *  subset of the original versions. */
+     * @{ */
     static Ptr instance(const Ptr&, const VersionNumbers&);
+    static Ptr instance(const Ptr&, const VersionMask&);
+    /** @} */
+
+    /** Restrict versions to those matching a pattern.
+     *
+     *  Returns the original if all its versions match, an instance with only the matching versions if some match, or null if
+     *  none match. */
+    static Ptr matching(const Ptr&, const PackagePattern&);
+
+    /** Restrict versions to those in common with another package.
+     *
+     *  Returns the original if all its versions are also versions of the @p other package, an instance with only the common
+     *  versions if there are some, or null if there are none. This uses only mask operations when both packages are ghosts
+     *  of the same definition. */
+    static Ptr intersection(const Ptr&, const PackagePtr &other);
+
+    /** Versions as a mask over the definition's version numbers. */
+    const VersionMask& versionMask() const { return versions_; }
 
     /** True if version is present in package. */
     bool isValidVersion(const VersionNumber&) const;
@@ -67,6 +97,12 @@ public:
      *  is already installed. When installing a package with parasites, the parasites are returned by the @p parasites
      *  argument. */
     PackagePtr install(Context &ctx, const VersionNumber&, Packages &parasites /*out*/);
+
+    /** Start downloading the package in the background.
+     *
+     *  The download is run by one of the workers, and a later @ref install of the same version waits for it. Parasites have
+     *  nothing to download. */
+    void prefetch(Context &ctx, const VersionNumber&, WorkQueue &workers);
 };
 
 } // namespace
@@ -0,0 +1,74 @@
+#ifndef Spock_InstallLock_H
+#define Spock_InstallLock_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Exclusive right to build one package configuration.
+ *
+ *  When several spock processes need the same missing package at the same time they would each build it under a different
+ *  random hash. Instead, the builder holds an flock on "CONFHASH.lock" in the installation directory, where CONFHASH is the
+ *  package's configuration hash, and other processes wait for the lock. The file records what its holder did ("building PID
+ *  HASH", then "installed HASH" followed by the specs of any parasites, or "failed HASH") so that a process that obtains the
+ *  lock after waiting can use the package that was just installed instead of building it again.
+ *
+ *  The kernel releases an flock when its holder dies, so a holder that crashed is recognized by a lock that can be obtained
+ *  but still says "building". The lock files themselves are never deleted since that would race with processes that have
+ *  them open. */
+class InstallLock {
+public:
+    /** What the previous holder of the lock did. */
+    struct State {
+        enum Type { NONE, BUILDING, INSTALLED, FAILED };
+        Type type;
+        int pid;                                        // process that was building, if BUILDING
+        std::string hash;                               // hash of the installation
+        std::vector<std::string> parasites;             // parasite specs, if INSTALLED
+        State(): type(NONE), pid(-1) {}
+    };
+
+private:
+    boost::filesystem::path fileName_;
+    int fd_;
+    State previous_;
+    std::string hash_;                                  // hash being built by this process
+    bool isBuilding_;                                   // building() called without installed() or failed()
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Obtain the lock, waiting as long as necessary.
+     *
+     *  While waiting, progress messages mention @p what is being built. Throws an Exception::ResourceError if the lock file
+     *  cannot be opened. */
+    InstallLock(const boost::filesystem::path &fileName, const std::string &what);
+
+    /** Release the lock, recording a failure if building was not finished. */
+    ~InstallLock();
+
+    /** State left by the previous holder. */
+    const State& previous() const { return previous_; }
+
+    /** True if the previous holder died while building. */
+    bool holderCrashed() const { return State::BUILDING == previous_.type; }
+
+    /** Record that this process is building the package with the specified hash. */
+    void building(const std::string &hash);
+
+    /** Record that the package and its parasites were installed. */
+    void installed(const std::string &hash, const Packages &parasites);
+
+    /** Record that building failed. */
+    void failed(const std::string &hash);
+
+private:
+    State readState() const;
+    void writeState(const std::string&);
+};
+
+} // namespace
+
+#endif
@@ -66,12 +66,19 @@ public:
     /** @} */
 
     /** Time stamp for last time this package was used by spock-shell.
+     *
+     *  Setting the time stamp appends it to the context's usage journal.
      *
      * @{ */
     const boost::posix_time::ptime& usedTimeStamp() const { return usedTimeStamp_; }
     void usedTimeStamp(const Context&, const boost::posix_time::ptime&);
     void stampUsedTime(const Context&);
     /** @} */
+
+    /** Stamp the installed packages of a list as used now.
+     *
+     *  All the packages are recorded in the usage journal with a single write. Packages that aren't installed are ignored. */
+    static void stampUsedTime(const Context&, const Packages&);
     
 
     /** Environment variable search paths.
@@ -92,8 +99,12 @@ public:
      *  The package object itself will still exist while there are references to it. */
     void remove(Context&);
 
-private:
-    boost::filesystem::path usedTimeStampFile(const Context&) const;
+    /** Remove the specified package by moving it to the trash.
+     *
+     *  Like @ref remove except the installation prefix is moved into the trash instead of being deleted, which is fast and
+     *  leaves the package database consistent. The trash must be emptied later. If the prefix can't be moved then it's
+     *  deleted as with @ref remove. */
+    void remove(Context&, Trash&);
 };
 
 } // namespace
@@ -0,0 +1,74 @@
+#ifndef Spock_Jobserver_H
+#define Spock_Jobserver_H
+
+#include <Spock/Environment.h>
+
+#include <Sawyer/Stopwatch.h>
+#include <boost/cstdint.hpp>
+
+#if SAWYER_MULTI_THREADED
+#include <boost/thread/thread.hpp>
+#endif
+
+namespace Spock {
+
+/** GNU make jobserver shared by everything a spock tool runs.
+ *
+ *  Each package's install script, and each "make" run inside an RMC environment, would otherwise choose its own parallelism,
+ *  which oversubscribes the host when several builds run at once. Instead, a spock tool can host a jobserver: a pipe holding
+ *  one token per job slot beyond the first. The pipe's file descriptors are inherited by child processes, and $MAKEFLAGS
+ *  tells GNU make 4.2 or later (and other tools that speak the protocol, such as recent versions of ninja) to read a token
+ *  before starting each job beyond its first and to write it back when the job finishes. Thus all the builds together never
+ *  run more than the configured number of jobs.
+ *
+ *  While the jobserver exists, a thread samples the number of tokens in the pipe in order to report how busy the jobs were
+ *  when the jobserver is destroyed. */
+class Jobserver {
+    size_t nTokens_;                                    // number of job slots, including each make's implicit slot
+    int readFd_, writeFd_;                              // ends of the token pipe
+#if SAWYER_MULTI_THREADED
+    boost::thread sampler_;
+#endif
+    uint64_t nSamples_;                                 // number of times the pipe was sampled
+    uint64_t totalInUse_;                               // sum of borrowed tokens over all samples
+    size_t maxInUse_;                                   // most tokens borrowed at once
+    Sawyer::Stopwatch lifetime_;                        // time since the jobserver was created
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Create a jobserver with the specified number of job slots.
+     *
+     *  Throws an Exception::ResourceError if the pipe cannot be created. */
+    explicit Jobserver(size_t nTokens);
+
+    /** Report utilization and close the pipe. */
+    ~Jobserver();
+
+    /** Default number of job slots.
+     *
+     *  This is $PARALLELISM if it's a positive integer, otherwise the number of processors. */
+    static size_t defaultTokens();
+
+    /** True if the environment already refers to a jobserver, such as when running inside another spock tool or make. */
+    static bool isInherited(const Environment&);
+
+    /** Number of job slots. */
+    size_t nTokens() const { return nTokens_; }
+
+    /** Point child processes at this jobserver.
+     *
+     *  Appends the jobserver switches to $MAKEFLAGS and sets $SPOCK_JOBSERVER and $PARALLELISM to the number of job slots. */
+    void exportTo(Environment&) const;
+    void exportTo(Context&) const;
+
+private:
+    std::string makeflags(const std::string &inherited) const;
+    size_t nAvailable() const;
+    void sample();
+    void sampleLoop();
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef Spock_LogFile_H
+#define Spock_LogFile_H
+
+#include <Spock/Spock.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Compressed, indexed log files.
+ *
+ *  Download, build, and post-install logs are kept as "NAME.gz", a series of independent gzip members that each hold about
+ *  256 KiB of output and normally end at a line boundary. Since a gzip file may consist of several members, the usual tools
+ *  ("zless", "zcat", etc.) read the log as one piece. The companion index "NAME.gz.idx" is a tab-separated text file with
+ *  one line "member N COFFSET CSIZE LINE NLINES" per member, giving its compressed byte range, the number of line feeds
+ *  that precede it, and the number of line feeds it contains. A member's index line is written after the member itself, so
+ *  a reader never sees a partial member.
+ *
+ *  @ref LogReader uses the index to fetch the last lines, or any range of lines, by decompressing only the members that hold
+ *  them. Logs written by older versions of spock are plain text files without the ".gz" suffix, and these can be read too.
+ *
+ *  This class has only static functions for naming and managing log files. */
+class LogFile {
+public:
+    /** Name of a compressed log for the plain log name, which is the name before compressed logs were used. */
+    static boost::filesystem::path compressedName(const boost::filesystem::path &plainName);
+
+    /** Name of the index for a compressed log. */
+    static boost::filesystem::path indexName(const boost::filesystem::path &logName);
+
+    /** True if the name is that of a compressed log. */
+    static bool isCompressed(const boost::filesystem::path &logName);
+
+    /** Find an existing log.
+     *
+     *  Given the plain name of a log, returns the name of the compressed log if it exists, else the plain name if that
+     *  exists, else an empty path. */
+    static boost::filesystem::path find(const boost::filesystem::path &plainName);
+
+    /** Rename a log and its index, if any. */
+    static void rename(const boost::filesystem::path &from, const boost::filesystem::path &to);
+
+    /** Remove a log and its index, if any. */
+    static void remove(const boost::filesystem::path &logName);
+};
+
+/** Writes a compressed log.
+ *
+ *  Data is buffered until a member is full or @ref flush is called, then compressed and appended to the log along with its
+ *  index line. */
+class LogWriter {
+    boost::filesystem::path fileName_;
+    int fd_, indexFd_;                                  // log and index, opened for appending
+    std::string buffer_;                                // data not yet written to any member
+    size_t memberSize_;                                 // approximate amount of data per member
+    size_t nMembers_;                                   // members written so far
+    uint64_t offset_;                                   // size of the log file
+    uint64_t nLines_;                                   // line feeds written so far
+
+public:
+    /** Create or truncate a log and its index.
+     *
+     *  Throws an Exception::ResourceError if either file can't be created. */
+    explicit LogWriter(const boost::filesystem::path &fileName, size_t memberSize = 256*1024);
+
+    /** Flush and close the log. */
+    ~LogWriter();
+
+    /** Append data to the log. */
+    void write(const char *data, size_t size);
+
+    /** Write buffered data as a member, if there is any. */
+    void flush();
+
+    /** Number of bytes buffered but not yet written. */
+    size_t nBuffered() const { return buffer_.size(); }
+
+private:
+    void writeMember(size_t size);
+};
+
+/** Reads a compressed or plain log. */
+class LogReader {
+    struct Member {
+        uint64_t offset, size;                          // compressed bytes in the log file
+        uint64_t firstLine;                             // number of line feeds before this member
+        uint64_t nLines;                                // number of line feeds in this member
+    };
+
+    boost::filesystem::path fileName_;
+    std::vector<Member> members_;
+    std::string plain_;                                 // entire log if it has no index
+
+public:
+    /** Open a log for reading.
+     *
+     *  A compressed log without a usable index, or a plain log, is read in its entirety. Throws an Exception::ResourceError
+     *  if the log cannot be read. */
+    explicit LogReader(const boost::filesystem::path &fileName);
+
+    /** Number of lines in the log. A final line without a line feed counts as a line. */
+    size_t nLines();
+
+    /** Lines in the half-open range @p begin to @p end, without their line feeds. Line numbers start at zero. */
+    std::vector<std::string> lines(size_t begin, size_t end);
+
+    /** Last @p n lines. */
+    std::vector<std::string> tail(size_t n);
+
+private:
+    std::string memberText(size_t i);
+    size_t memberWithLineFeed(uint64_t lf) const;
+};
+
+} // namespace
+
+#endif
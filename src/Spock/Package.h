@@ -49,8 +49,8 @@ public:
     /** Primary Version number.
      *
      *  Installed packages have only one version number and that's what's returned.  Ghost packages are placeholders for one or
-     *  more versions, and querying the version returns the best (highest) version. Setting the version of a ghost package adds
-     *  the specified version to the set of versions.
+     *  more versions, and querying the version returns the best (highest) version. Ghost packages are shared and their
+     *  versions cannot be set; use GhostPackage::instance to obtain a ghost with other versions.
      *
      * @{ */
     virtual VersionNumber version() const = 0;
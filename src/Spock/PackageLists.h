@@ -5,6 +5,12 @@
 
 namespace Spock {
 
+/** Package ordering used for package lists.
+ *
+ *  Installed packages come before packages that are not installed, then packages are sorted alphabetically by name, then by
+ *  descending version number, then by descending installation time stamp, and finally by hash. */
+bool sortByNameVersion(const PackagePtr&, const PackagePtr&);
+
 /** List of lists of packages.
  *
  * This class contains a list of lists of packages. For instance, if the user wants to use boost-1.62 and gcc-4.8, then the
@@ -13,7 +19,19 @@ namespace Spock {
  * from the first list and an installed compiler from the second list will be valid. The goal is to choose just one boost
  * that's compatible with one compiler. */
 class PackageLists {
+    // One entry of the undo trail: either a package was pruned from a list, or a list was inserted.
+    struct Change {
+        size_t listNumber;
+        size_t packageNumber;                           // INSERTED if the list was inserted
+        Change(size_t listNumber, size_t packageNumber): listNumber(listNumber), packageNumber(packageNumber) {}
+    };
+
+    static const size_t INSERTED = (size_t)(-1);
+
     std::vector<Packages> lists_;
+    std::vector<std::vector<bool> > pruned_;            // parallel to lists_; packages that have been pruned
+    std::vector<size_t> nActive_;                       // parallel to lists_; number of packages not pruned
+    std::vector<Change> trail_;                         // changes that can be undone
 
 public:
     PackageLists();
@@ -30,13 +48,36 @@ public:
      *  Reduces this package lists to contain only @p n lists. @p n must not be larger than the current number of lists. */
     void resize(size_t n);
 
+    /** Number of packages in a sublist that have not been pruned. */
+    size_t nActive(size_t listNumber) const;
+
+    /** True if a package has been pruned from its sublist. */
+    bool isPruned(size_t listNumber, size_t packageNumber) const;
+
+    /** Prune a package from a sublist.
+     *
+     *  The package remains in the list (so package numbers don't change) but is marked as no longer a candidate. Pruning is
+     *  recorded on the undo trail. Pruning a package that's already pruned does nothing. */
+    void prune(size_t listNumber, size_t packageNumber);
+
+    /** Position in the undo trail.
+     *
+     *  Inserting lists and pruning packages are recorded on a trail so that a search can backtrack by undoing only what
+     *  changed since a mark instead of saving copies of the lists. */
+    size_t mark() const { return trail_.size(); }
+
+    /** Undo changes back to a mark.
+     *
+     *  Lists inserted and packages pruned after the mark was obtained are removed and restored, respectively. */
+    void undo(size_t mark);
+
     /** A particular package sublist. */
     const Packages& operator[](size_t listNumber) const;
 
     /** True if this object has no package lists. */
     bool isEmpty() const { return lists_.empty(); }
 
-    /** True if any list exists but is empty. */
+    /** True if any list exists but is empty or has had all its packages pruned. */
     bool isAnyListEmpty() const;
 
     /** Insert a list of packages. */
@@ -53,13 +94,14 @@ public:
 
     /** Sort individual package lists.
      *
-     *  This sorts packages so the "best" packages are at the front of the list. */
+     *  This sorts packages so the "best" packages are at the front of the list. Sorting is only allowed when nothing has been
+     *  pruned, and it clears the undo trail. */
     void sortPackages();
 
     /** Sort lists by size.
      *
      *  Rearrange the sublists within the top-level list so shorter lists are before longer lists. This makes the search
-     *  algorithm more efficient. */
+     *  algorithm more efficient. Sorting is only allowed when nothing has been pruned, and it clears the undo trail. */
     void sortLists();
 
     /** Complete sorting.
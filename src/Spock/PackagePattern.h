@@ -60,6 +60,14 @@ public:
     /** Convert pattern to string. */
     std::string toString() const;
 
+    /** True if the name part of the pattern contains a "*". */
+    bool isGlob() const { return pkgName_.find('*') != std::string::npos; }
+
+    /** Does the name part of the pattern match a name?
+     *
+     *  An empty name part matches everything, and each "*" matches zero or more characters. */
+    bool matchesName(const std::string&) const;
+
     /** Does the pattern match a package? */
     bool matches(const PackagePtr&) const;
 
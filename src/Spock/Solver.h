@@ -2,24 +2,41 @@
 #define Spock_Solver_H
 
 #include <Spock/Context.h>
+#include <Spock/PackageLists.h>
+
+#include <boost/shared_ptr.hpp>
 
 namespace Spock {
 
-/** Solves package constraints. */
+class SolutionIterator;
+
+/** Solves package constraints.
+ *
+ *  Solutions can be found all at once with @ref solve, which keeps up to @ref maxSolutions of them, or one at a time on
+ *  demand with a @ref SolutionIterator. */
 class Solver {
+    friend class SolutionIterator;
+
 public:
     typedef Packages Solution;
     typedef Packages Constraints;
 
+    /** Shared, read-only solution.
+     *
+     *  Solutions are not modified once found, so they're shared instead of being copied. */
+    typedef boost::shared_ptr<const Solution> SolutionPtr;
+
 private:
     const Context &ctx_;
     size_t maxSolutions_;                               // max number of solutions to find
-    std::vector<Solution> solutions_;
+    std::vector<SolutionPtr> solutions_;
     Sawyer::Container::Set<std::string> messageSet_;
     std::string latestMessage_;
     bool fullSolutions_;                                // if true, then include all dependencies in solutions
     bool onlyInstalled_;                                // find solutions that have only installed packages
     size_t nSteps_;                                     // number of steps performed to find solution(s)
+    bool forwardChecking_;                              // prune candidates as soon as constraints change
+    Compatibility::TablePtr compatibility_;             // cached relationships as of the start of the current solve
 
 public:
     static Sawyer::Message::Facility mlog;
@@ -50,6 +67,22 @@ public:
     void onlyInstalled(bool b) { onlyInstalled_ = b; }
     /** @} */
 
+    /** Whether to use forward checking.
+     *
+     *  When forward checking is enabled, every time a package is added to the partial solution the candidates in the package
+     *  lists not yet visited are checked against the new constraints, and those that are excluded are pruned. A list that
+     *  loses all its candidates causes the solver to backtrack immediately instead of discovering the conflict at a deeper
+     *  level. The next list to visit is then chosen dynamically as the one with the fewest remaining candidates (the first
+     *  such list if there's a tie). Pruning never changes the set of solutions, but the dynamic ordering can change the
+     *  order in which they're found, so callers that rely on the first solution (e.g., the "code-generation" list being
+     *  decided first) should leave it off. When disabled, lists are visited in the order they were created. The default is
+     *  disabled.
+     *
+     * @{ */
+    bool forwardChecking() const { return forwardChecking_; }
+    void forwardChecking(bool b) { forwardChecking_ = b; }
+    /** @} */
+
     /** Find solutions.
      *
      *  Given a single pattern or a list of patterns for packages that are required (combined with the list of packages that
@@ -63,8 +96,12 @@ public:
     /** Number of solutions found. */
     size_t nSolutions() const { return solutions_.size(); }
 
-    /** Return a previously found solution. */
+    /** Return a previously found solution.
+     *
+     * @{ */
     const Solution& solution(size_t solutionNumber) const;
+    SolutionPtr solutionPtr(size_t solutionNumber) const;
+    /** @} */
 
     /** Error messages from last solve attempt.
      *
@@ -90,11 +127,91 @@ private:
     // These internal functions are documented in the .C file.
     void insertMessage(const std::string&);
     const std::string& latestMessage() const { return latestMessage_; }
+    void resetResults();
     void extendLists(const Constraints&, PackageLists &plists /*in,out*/, const std::vector<PackagePattern>&);
-    void solve(const Constraints&, PackageLists&, std::vector<size_t> &plistIndexes);
+    unsigned relation(const PackagePtr&, const PackagePtr&) const;
+    bool excludes(const PackagePtr &constraint, const PackagePtr&, std::string &failure /*out*/) const;
+    size_t nextList(const PackageLists&, const std::vector<size_t> &plistIndexes) const;
+    bool forwardCheck(const Constraints &changed, PackageLists&, const std::vector<size_t> &plistIndexes, size_t callDepth);
     Constraints appendConstraint(const Constraints&, const PackagePtr&, size_t callDepth, bool &needDeps /*out*/);
 };
 
+/** Finds solutions one at a time.
+ *
+ *  The iterator performs the same depth-first search as @ref Solver::solve, but keeps its search stack between calls to @ref
+ *  next so that each call resumes where the previous one stopped and finds only one more solution. This is useful when a tool
+ *  wants to try the first solution and fall back to the next one only if the first doesn't work out, or wants the first few
+ *  solutions without deciding up front how many. Solutions are not accumulated, so memory is bounded by the depth of the
+ *  search regardless of how many solutions are enumerated.
+ *
+ *  The iterator uses the solver's settings, except @ref Solver::maxSolutions which doesn't apply, and these should not be
+ *  changed while the iterator is in use. The solver's messages and step count accumulate as the iterator advances. The
+ *  solver and its context must outlive the iterator.
+ *
+ * @code
+ *  Solver solver(ctx);
+ *  SolutionIterator solutions(solver, patterns);
+ *  while (Solver::SolutionPtr soln = solutions.next()) {
+ *      if (tryToUse(*soln))
+ *          break;
+ *  }
+ * @endcode */
+class SolutionIterator {
+    // One level of the search: the package list being chosen from and the candidates that remain to be tried.
+    struct Frame {
+        size_t listNumber;                              // package list from which this level chooses
+        size_t candidate;                               // next candidate in the list to try
+        size_t mark;                                    // package list undo trail position when this level was entered
+        size_t constraintMark;                          // constraint undo trail position when this level was entered
+        bool isTrying;                                  // whether a candidate is chosen and needs to be undone
+    };
+
+    // One change to constraints_, so it can be undone. The old value is null if the constraint was appended.
+    struct ConstraintChange {
+        size_t index;                                   // position in constraints_ that changed
+        PackagePtr old;                                 // previous constraint at that position, or null
+    };
+
+    Solver &solver_;
+    PackageLists plists_;
+    std::vector<size_t> plistIndexes_;                  // chosen package in each list, or UNCHOSEN
+    Solver::Constraints constraints_;                   // constraints of the partial solution at the deepest level
+    std::vector<ConstraintChange> constraintTrail_;     // changes to constraints_ so they can be undone
+    std::vector<Frame> stack_;
+    Solver::SolutionPtr pending_;                       // solution found before the first call to next
+    size_t nFound_;                                     // number of solutions returned so far
+
+public:
+    /** Start a search.
+     *
+     *  Given a single pattern or a list of patterns for packages that are required (combined with the list of packages that
+     *  are already being used by the solver's context), prepares to find solutions. The solver's messages and step count are
+     *  reset.
+     *
+     * @{ */
+    SolutionIterator(Solver&, const PackagePattern&);
+    SolutionIterator(Solver&, const std::vector<PackagePattern>&);
+    /** @} */
+
+    /** Find the next solution.
+     *
+     *  Returns the next solution, or a null pointer if there are no more. */
+    Solver::SolutionPtr next();
+
+    /** Number of solutions returned so far. */
+    size_t nFound() const { return nFound_; }
+
+private:
+    // Not copyable since the search state is large and tied to one solver.
+    SolutionIterator(const SolutionIterator&);
+    SolutionIterator& operator=(const SolutionIterator&);
+
+    void start(const std::vector<PackagePattern>&);
+    Solver::SolutionPtr enter();
+    void assignConstraints(const Solver::Constraints&, Solver::Constraints &changed /*out*/);
+    void undoConstraints(size_t mark);
+};
+
 } // namespace
 
 #endif
@@ -33,6 +33,8 @@ typedef Sawyer::SharedPointer<class GlobalFlag> GlobalFlagPtr;
 class Context;
 class PackagePattern;
 class PackageLists;
+class Trash;
+class WorkQueue;
 
 /** Initialize this library.
  *
@@ -47,6 +49,9 @@ Sawyer::CommandLine::Parser commandLineParser(const std::string &purpose, const
 /** Escape special characters like in C strings. */
 std::string cEscape(const std::string&);
 
+/** Quote a string as a JSON string literal. */
+std::string jsonString(const std::string&);
+
 /** Determine whether a string is a valid hash. */
 bool isHash(const std::string&);
 
@@ -56,6 +61,18 @@ std::string randomHash();
 /** Return a string like "a, b, and c". If terse is true then omit the "and". */
 std::string toString(const Aliases&, bool terse = false);
 
+/** Parse a size like "500M" or "2G".
+ *
+ *  The size is a non-negative integer number of bytes optionally followed by "K", "M", "G", or "T" (powers of 1024). Throws
+ *  an Exception::SyntaxError if the string is not a valid size. */
+uint64_t parseSize(const std::string&);
+
+/** Format a number of bytes for people, like "1.5 GiB". */
+std::string sizeToString(uint64_t nBytes);
+
+/** Format a number of seconds for people, like "45s", "12m05s", or "1h02m". */
+std::string durationToString(double seconds);
+
 /** Checked conversion to installed package. */
 InstalledPackagePtr asInstalled(const PackagePtr&);
 
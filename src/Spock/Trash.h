@@ -0,0 +1,49 @@
+#ifndef Spock_Trash_H
+#define Spock_Trash_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+
+namespace Spock {
+
+/** Directory of installation trees waiting to be deleted.
+ *
+ *  Deleting a large installed package can take minutes, especially on network file systems. Instead, a removed package's
+ *  installation prefix is renamed into the ".trash" directory under $SPOCK_OPTDIR, which is on the same file system and thus
+ *  specific to the host. Renaming is fast and atomic, so the package database is consistent as soon as the package's YAML
+ *  file is gone and its prefix is in the trash. The trees in the trash are deleted later by @ref empty, which can be
+ *  interrupted and resumed at any time. */
+class Trash {
+    boost::filesystem::path directory_;
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** The trash for the installed packages of a context. */
+    explicit Trash(const Context&);
+
+    /** Name of the trash directory. */
+    const boost::filesystem::path& directory() const { return directory_; }
+
+    /** Move a file or directory into the trash.
+     *
+     *  Does nothing if the path does not exist. Throws an Exception::ResourceError if it cannot be moved, such as when it's on
+     *  a different file system than the trash. */
+    void insert(const boost::filesystem::path&);
+
+    /** True if there is nothing in the trash. */
+    bool isEmpty() const;
+
+    /** Delete everything in the trash.
+     *
+     *  The top levels of each tree are walked by the calling thread and their subtrees are deleted in parallel by the
+     *  specified number of threads (zero means one per processor). Anything added to the trash while this is running is also
+     *  deleted. Several processes may empty the same trash at once. Throws an Exception::CommandError if something could not
+     *  be deleted. */
+    void empty(size_t nThreads = 0);
+};
+
+} // namespace
+
+#endif
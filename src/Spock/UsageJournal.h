@@ -0,0 +1,69 @@
+#ifndef Spock_UsageJournal_H
+#define Spock_UsageJournal_H
+
+#include <Spock/Spock.h>
+
+#include <boost/filesystem.hpp>
+#include <ctime>
+
+namespace Spock {
+
+/** When installed packages were last used.
+ *
+ *  Every spock-shell records the packages it employs so that unused packages can be found and removed. Rather than touching
+ *  one file per package, each use appends one line per package ("HASH UNIX_TIME") to "usage.journal" in $SPOCK_OPTDIR with a
+ *  single O_APPEND write. Reading the times means reading that one file. When the journal grows large, it's compacted into
+ *  "usage.snapshot", which holds only the latest time for each package that's still installed, and the journal is emptied.
+ *
+ *  Appending holds a shared lock on "usage.lock" and compacting holds an exclusive lock, so a compaction never loses a
+ *  concurrent append. The older per-package "HASH.used" files are imported into the snapshot and deleted the first time the
+ *  snapshot is created.
+ *
+ *  The journal is loaded the first time a time is needed. */
+class UsageJournal {
+    typedef Sawyer::Container::Map<std::string /*hash*/, std::time_t> Times;
+
+    boost::filesystem::path optdir_;
+    bool isLoaded_;
+    Times times_;                                       // latest use of each package
+    uint64_t journalOffset_;                            // how much of the journal has been read
+    std::time_t snapshotTime_;                          // modification time of snapshot when read
+
+public:
+    static Sawyer::Message::Facility mlog;
+
+    /** Journal for packages installed in the specified directory. */
+    explicit UsageJournal(const boost::filesystem::path &optdir = boost::filesystem::path());
+
+    /** Directory containing the journal. */
+    const boost::filesystem::path& directory() const { return optdir_; }
+    void directory(const boost::filesystem::path&);
+
+    /** Last time a package was used, or zero if unknown. */
+    std::time_t lastUsed(const std::string &hash);
+
+    /** Record that packages were used at the specified time.
+     *
+     *  All the records are appended with a single write. Errors are reported as warnings since usage times are advisory. */
+    void record(const std::vector<std::string> &hashes, std::time_t);
+
+    /** Read whatever other processes have appended since the journal was loaded. */
+    void refresh();
+
+    /** Compact the journal into the snapshot now.
+     *
+     *  Returns false if another process holds the lock. */
+    bool compact();
+
+private:
+    boost::filesystem::path journalName() const;
+    boost::filesystem::path snapshotName() const;
+    boost::filesystem::path lockName() const;
+    void load();
+    void readRecords(const boost::filesystem::path&, uint64_t offset, Times&, uint64_t *endOffset = NULL) const;
+    void importUsedFiles(Times&) const;
+};
+
+} // namespace
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <Spock/Spock.h>
 #include <Sawyer/Set.h>
+#include <boost/cstdint.hpp>
 
 namespace Spock {
 
@@ -80,6 +81,115 @@ public:
 
 typedef Sawyer::Container::Set<VersionNumber> VersionNumbers;
 
+/** Set of versions of one package definition.
+ *
+ *  Each package definition numbers its versions densely from zero in ascending version order (see @ref
+ *  DefinedPackage::versionIndex), and a version mask has one bit per version number. Intersection, union, and subset tests
+ *  are therefore a few word-wise operations instead of set operations on version numbers. The width is fixed so that masks
+ *  can be copied and compared without allocation, which limits a package definition to @ref MAX_VERSIONS versions. */
+class VersionMask {
+public:
+    enum { MAX_VERSIONS = 256 };
+
+private:
+    enum { BITS_PER_WORD = 64, NWORDS = MAX_VERSIONS / BITS_PER_WORD };
+    uint64_t words_[NWORDS];
+
+public:
+    /** Construct an empty set. */
+    VersionMask() {
+        for (size_t i=0; i<NWORDS; ++i)
+            words_[i] = 0;
+    }
+
+    /** True if the set is empty. */
+    bool isEmpty() const {
+        for (size_t i=0; i<NWORDS; ++i) {
+            if (words_[i] != 0)
+                return false;
+        }
+        return true;
+    }
+
+    /** Number of versions in the set. */
+    size_t size() const {
+        size_t n = 0;
+        for (size_t i=0; i<NWORDS; ++i)
+            n += __builtin_popcountll(words_[i]);
+        return n;
+    }
+
+    /** True if the set contains the specified version index. */
+    bool exists(size_t idx) const {
+        ASSERT_require(idx < MAX_VERSIONS);
+        return (words_[idx / BITS_PER_WORD] >> (idx % BITS_PER_WORD)) & 1;
+    }
+
+    /** Insert a version index. */
+    void insert(size_t idx) {
+        ASSERT_require(idx < MAX_VERSIONS);
+        words_[idx / BITS_PER_WORD] |= (uint64_t)1 << (idx % BITS_PER_WORD);
+    }
+
+    /** Largest version index in the set, which is the greatest version. The set must not be empty. */
+    size_t greatest() const {
+        for (size_t i=NWORDS; i>0; --i) {
+            if (words_[i-1] != 0)
+                return (i-1) * BITS_PER_WORD + BITS_PER_WORD - 1 - __builtin_clzll(words_[i-1]);
+        }
+        ASSERT_not_reachable("empty version mask");
+    }
+
+    /** True if every version in this set is also in the @p other set. */
+    bool isSubsetOf(const VersionMask &other) const {
+        for (size_t i=0; i<NWORDS; ++i) {
+            if ((words_[i] & ~other.words_[i]) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    /** Versions in both sets. */
+    VersionMask operator&(const VersionMask &other) const {
+        VersionMask retval;
+        for (size_t i=0; i<NWORDS; ++i)
+            retval.words_[i] = words_[i] & other.words_[i];
+        return retval;
+    }
+
+    /** Versions in either set. */
+    VersionMask operator|(const VersionMask &other) const {
+        VersionMask retval;
+        for (size_t i=0; i<NWORDS; ++i)
+            retval.words_[i] = words_[i] | other.words_[i];
+        return retval;
+    }
+
+    /** Set equality.
+     *
+     * @{ */
+    bool operator==(const VersionMask &other) const {
+        for (size_t i=0; i<NWORDS; ++i) {
+            if (words_[i] != other.words_[i])
+                return false;
+        }
+        return true;
+    }
+    bool operator!=(const VersionMask &other) const {
+        return !(*this == other);
+    }
+    /** @} */
+
+    /** Arbitrary total order so masks can be used as map keys. */
+    bool operator<(const VersionMask &other) const {
+        for (size_t i=0; i<NWORDS; ++i) {
+            if (words_[i] != other.words_[i])
+                return words_[i] < other.words_[i];
+        }
+        return false;
+    }
+};
+
 } // namespace
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef Spock_Wire_H
+#define Spock_Wire_H
+
+#include <Spock/Spock.h>
+
+#include <boost/cstdint.hpp>
+
+namespace Spock {
+
+/** Encodes values into a compact binary buffer.
+ *
+ *  All integers are little-endian and fixed width. Strings are a 32-bit length followed by the bytes (no NUL
+ *  terminator). Lists are a 32-bit count followed by the items. The encoding is only meant to be read back by a
+ *  @ref WireReader of the same spock version, so there is no attempt at self-description. */
+class WireWriter {
+    std::string buffer_;
+
+public:
+    /** Append a single byte. */
+    WireWriter& u8(uint8_t);
+
+    /** Append a 32-bit unsigned integer. */
+    WireWriter& u32(uint32_t);
+
+    /** Append a 64-bit unsigned integer. */
+    WireWriter& u64(uint64_t);
+
+    /** Append a length-encoded string. */
+    WireWriter& string(const std::string&);
+
+    /** Append a list of length-encoded strings. */
+    WireWriter& strings(const std::vector<std::string>&);
+
+    /** Append everything encoded by another writer. */
+    WireWriter& append(const WireWriter&);
+
+    /** Bytes encoded so far. */
+    const std::string& buffer() const { return buffer_; }
+
+    /** Discard everything encoded so far. */
+    void clear() { buffer_.clear(); }
+};
+
+/** Decodes values from a buffer produced by @ref WireWriter.
+ *
+ *  Reading past the end of the buffer throws an Exception::SyntaxError, so a truncated or corrupt message is never
+ *  silently interpreted. The reader does not own the bytes; the buffer must outlive the reader. */
+class WireReader {
+    const char *data_;
+    size_t size_;
+    size_t offset_;
+
+public:
+    WireReader(const char *data, size_t size)
+        : data_(data), size_(size), offset_(0) {}
+
+    explicit WireReader(const std::string &buffer)
+        : data_(buffer.data()), size_(buffer.size()), offset_(0) {}
+
+    uint8_t u8();
+    uint32_t u32();
+    uint64_t u64();
+    std::string string();
+    std::vector<std::string> strings();
+
+    /** True if every byte has been consumed. */
+    bool atEnd() const { return offset_ >= size_; }
+
+private:
+    const char* consume(size_t nBytes);
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef Spock_WorkQueue_H
+#define Spock_WorkQueue_H
+
+#include <Spock/Spock.h>
+
+#include <boost/function.hpp>
+#include <deque>
+#include <string>
+
+#if SAWYER_MULTI_THREADED
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+namespace Spock {
+
+/** Bounded pool of worker threads.
+ *
+ *  Tasks are inserted by one thread and run by a fixed number of workers. The number of queued tasks is limited so that a
+ *  producer that generates work faster than it can be done is slowed down instead of using unbounded memory. Tasks must not
+ *  insert more tasks into the same queue.
+ *
+ *  If a task throws an exception then the remaining tasks still run, and @ref wait throws an Exception::CommandError with
+ *  the message from the first failure. If Spock is configured without multi-thread support then tasks run immediately in the
+ *  calling thread.
+ *
+ *  After @ref cancel, tasks that haven't started yet are discarded, and so are any that are inserted later. */
+class WorkQueue {
+public:
+    typedef boost::function<void()> Task;
+
+private:
+#if SAWYER_MULTI_THREADED
+    boost::mutex mutex_;
+    boost::condition_variable workAvailable_;           // signaled when a task is inserted or shutting down
+    boost::condition_variable spaceAvailable_;          // signaled when a task is removed from the queue
+    boost::condition_variable allDone_;                 // signaled when the queue is empty and no task is running
+    boost::thread_group workers_;
+#endif
+    std::deque<Task> tasks_;                            // tasks not started yet
+    size_t maxQueued_;                                  // maximum size of tasks_
+    size_t nRunning_;                                   // tasks currently running
+    bool shuttingDown_;                                 // tells workers to exit
+    bool isCancelled_;                                  // discard tasks instead of running them
+    std::string firstError_;                            // message from first failed task
+    size_t nErrors_;                                    // number of tasks that failed
+
+public:
+    /** Start the workers.
+     *
+     *  A thread count of zero means use one thread per processor. A queue limit of zero means four tasks per thread. */
+    explicit WorkQueue(size_t nThreads = 0, size_t maxQueued = 0);
+
+    /** Waits for all tasks to finish, then stops the workers. Errors are not reported. */
+    ~WorkQueue();
+
+    /** Number of threads that would be used for a thread count of zero. */
+    static size_t defaultThreads();
+
+    /** Add a task, blocking while the queue is full. */
+    void insert(const Task&);
+
+    /** Wait for all inserted tasks to finish.
+     *
+     *  Throws an Exception::CommandError if any task failed since the last call. */
+    void wait();
+
+    /** Discard tasks that haven't started.
+     *
+     *  Tasks that are already running are not interrupted. This is for error paths, so that destroying the queue doesn't
+     *  wait for work whose results are no longer needed. */
+    void cancel();
+
+private:
+    void worker();
+    void run(const Task&);
+};
+
+} // namespace
+
+#endif